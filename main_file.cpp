@@ -1,13 +1,33 @@
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <string>
+#include <string_view>
+#include <numeric>
+#include <iterator>
+#include <limits>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <iostream>
 #include <iomanip>
 #include <ncurses.h>
@@ -26,8 +46,10 @@ const string kUptimeFilename{"/uptime"};
 const string kStatFilename{"/stat"};
 const string kCmdlineFilename{"/cmdline"};
 const string kStatusFilename{"/status"};
+const string kPressureDirectory{"/proc/pressure/"};
 const string kOSPath{"/etc/os-release"};
 const string kPasswordPath{"/etc/passwd"};
+const int kAgentPort{7410};
 
 // -----------------------------------------------------------------------------
 // Helper: Format elapsed time
@@ -47,22 +69,116 @@ string ElapsedTime(long seconds) {
 // LinuxParser namespace
 // -----------------------------------------------------------------------------
 namespace LinuxParser {
-string KeyValParser(string key, string path) {
-  string value = "n/a", temp, line;
-  std::ifstream stream(path);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> temp;
-      if (temp == key) {
-        linestream >> value;
-        break;
+// Compile-time schema for "key value" files such as meminfo, status and
+// stat: each Key names the first token of a line and the integer member of
+// Record that receives the number following it.
+template <typename Record>
+struct Key {
+  std::string_view name;
+  long Record::*value;
+};
+
+template <typename Record, size_t N>
+constexpr bool UniqueKeys(Key<Record> const (&keys)[N]) {
+  for (size_t i = 0; i < N; ++i)
+    for (size_t j = i + 1; j < N; ++j)
+      if (keys[i].name == keys[j].name) return false;
+  return true;
+}
+
+// Parses the integer at p in place, skipping leading blanks.
+inline long ParseLong(char const* p, char const* end) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  bool negative = p < end && *p == '-';
+  if (negative) ++p;
+  long value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) value = value * 10 + (*p - '0');
+  return negative ? -value : value;
+}
+
+// One streaming pass over path that fills every member named by Keys and
+// stops reading as soon as all of them have been found. Lines are matched in
+// the fixed read buffer, so nothing is copied or allocated. Returns false if
+// the file cannot be read or a key is missing.
+template <auto const& Keys, typename Record>
+bool ParseKeys(char const* path, Record& record) {
+  constexpr size_t kCount = std::size(Keys);
+  static_assert(kCount > 0 && kCount <= 32, "a schema holds 1 to 32 keys");
+  static_assert(UniqueKeys(Keys), "schema keys must be unique");
+  constexpr uint32_t kAll = kCount == 32 ? ~0u : (1u << kCount) - 1;
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  char buf[4096];
+  size_t filled = 0;
+  uint32_t found = 0;
+  bool eof = false, skipping = false;
+  while (found != kAll && !eof) {
+    ssize_t n = read(fd, buf + filled, sizeof(buf) - filled);
+    if (n <= 0) {
+      eof = true;
+      if (filled == 0) break;
+      buf[filled++] = '\n';  // terminate a final unterminated line
+    } else {
+      filled += n;
+    }
+    char const* line = buf;
+    char const* end = buf + filled;
+    for (char const* nl; found != kAll && (nl = static_cast<char const*>(memchr(line, '\n', end - line)));
+         line = nl + 1) {
+      // The tail of a line longer than the buffer carries no key.
+      if (skipping) {
+        skipping = false;
+        continue;
+      }
+      for (size_t k = 0; k < kCount; ++k) {
+        std::string_view name = Keys[k].name;
+        size_t length = nl - line;
+        if (!(found & (1u << k)) && length > name.size() && std::string_view(line, name.size()) == name &&
+            (line[name.size()] == ' ' || line[name.size()] == '\t')) {
+          record.*(Keys[k].value) = ParseLong(line + name.size(), nl);
+          found |= 1u << k;
+          break;
+        }
       }
     }
+    // Keep the partial last line for the next read, or drop it if it fills
+    // the whole buffer.
+    filled = end - line;
+    if (filled == sizeof(buf)) {
+      filled = 0;
+      skipping = true;
+    } else {
+      memmove(buf, line, filled);
+    }
   }
-  return value;
+  close(fd);
+  return found == kAll;
 }
 
+struct MemInfo {
+  long total{0}, free{0};
+};
+constexpr Key<MemInfo> kMemInfoKeys[] = {{"MemTotal:", &MemInfo::total}, {"MemFree:", &MemInfo::free}};
+
+struct ProcessTotals {
+  long total{0}, running{0};
+};
+constexpr Key<ProcessTotals> kProcessCountKeys[] = {{"processes", &ProcessTotals::total},
+                                                    {"procs_running", &ProcessTotals::running}};
+
+struct ProcessStatus {
+  long uid{0}, vmSize{0}, vmRss{0};
+};
+constexpr Key<ProcessStatus> kProcessStatusKeys[] = {
+    {"Uid:", &ProcessStatus::uid}, {"VmSize:", &ProcessStatus::vmSize}, {"VmRSS:", &ProcessStatus::vmRss}};
+
+// Real uid only; the pass stops at the Uid: line near the top of status.
+struct ProcessOwner {
+  long uid{-1};
+};
+constexpr Key<ProcessOwner> kProcessOwnerKeys[] = {{"Uid:", &ProcessOwner::uid}};
+
 string OperatingSystem() {
   string line, key, value = "n/a";
   std::ifstream filestream(kOSPath);
@@ -92,22 +208,6 @@ string Kernel() {
   return kernel;
 }
 
-vector<int> Pids() {
-  vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    if (file->d_type == DT_DIR) {
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        pids.push_back(stoi(filename));
-      }
-    }
-  }
-  closedir(directory);
-  return pids;
-}
-
 vector<string> CpuUtilization() {
   vector<string> values;
   string line, key, val;
@@ -125,11 +225,10 @@ vector<string> CpuUtilization() {
 }
 
 float MemoryUtilization() {
-  string memTotalStr = KeyValParser("MemTotal:", kProcDirectory + kMeminfoFilename);
-  string memFreeStr = KeyValParser("MemFree:", kProcDirectory + kMeminfoFilename);
-  float memTotal = std::stof(memTotalStr);
-  float memFree = std::stof(memFreeStr);
-  return (memTotal - memFree) / memTotal;
+  static const string path = kProcDirectory + kMeminfoFilename;
+  MemInfo info;
+  if (!ParseKeys<kMemInfoKeys>(path.c_str(), info) || info.total <= 0) return 0.0;
+  return static_cast<float>(info.total - info.free) / info.total;
 }
 
 long UpTime() {
@@ -141,12 +240,11 @@ long UpTime() {
   return uptime;
 }
 
-int TotalProcesses() {
-  return stoi(KeyValParser("processes", kProcDirectory + kStatFilename));
-}
-
-int RunningProcesses() {
-  return stoi(KeyValParser("procs_running", kProcDirectory + kStatFilename));
+ProcessTotals ProcessCounts() {
+  static const string path = kProcDirectory + kStatFilename;
+  ProcessTotals counts;
+  ParseKeys<kProcessCountKeys>(path.c_str(), counts);
+  return counts;
 }
 
 long Jiffies() {
@@ -166,61 +264,52 @@ long IdleJiffies() {
   return stol(cpu[3]) + stol(cpu[4]);
 }
 
-string Uid(int pid) {
-  return KeyValParser("Uid:", kProcDirectory + to_string(pid) + kStatusFilename);
+// Reads path into buf with plain open/read so the per-process collection
+// loop never touches the heap. Returns the byte count, or -1 on failure.
+long ReadFile(const char* path, char* buf, size_t size) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  size_t total = 0;
+  while (total + 1 < size) {
+    ssize_t n = read(fd, buf + total, size - 1 - total);
+    if (n <= 0) break;
+    total += n;
+  }
+  close(fd);
+  buf[total] = '\0';
+  return total;
 }
 
-string User(int pid) {
-  string uid = Uid(pid), line, user, x, id;
+// Numeric fields 4 (ppid) to 24 (rss) of a /proc/[pid]/stat line, indexed by
+// their proc(5) field number.
+struct StatFields {
+  long values[21];
+
+  // comm may contain spaces, so resume after its closing parenthesis and
+  // skip the one-letter state.
+  bool Parse(char* line) {
+    char* p = strrchr(line, ')');
+    if (!p || p[1] == '\0' || p[2] == '\0') return false;
+    p += 3;
+    for (long& value : values) value = strtol(p, &p, 10);
+    return true;
+  }
+  long operator[](int field) const { return values[field - 4]; }
+  long Jiffies() const { return (*this)[14] + (*this)[15] + (*this)[16] + (*this)[17]; }
+};
+
+std::unordered_map<int, string> UserNames() {
+  std::unordered_map<int, string> users;
+  string line, user, x, id;
   std::ifstream stream(kPasswordPath);
   if (stream.is_open()) {
     while (std::getline(stream, line)) {
       std::replace(line.begin(), line.end(), ':', ' ');
       std::istringstream linestream(line);
-      linestream >> user >> x >> id;
-      if (id == uid) return user;
+      if (linestream >> user >> x >> id) users.emplace(stoi(id), user);
     }
   }
-  return "n/a";
-}
-
-string Command(int pid) {
-  string line;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kCmdlineFilename);
-  if (stream.is_open()) std::getline(stream, line);
-  return line;
-}
-
-string Ram(int pid) {
-  return KeyValParser("VmSize:", kProcDirectory + to_string(pid) + kStatusFilename);
-}
-
-long ActiveJiffies(int pid) {
-  string line, value;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    vector<string> values;
-    for (string s; linestream >> s;) values.push_back(s);
-    if (values.size() > 16)
-      return stol(values[13]) + stol(values[14]) + stol(values[15]) + stol(values[16]);
-  }
-  return 0;
-}
-
-long UpTime(int pid) {
-  string line;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    vector<string> values;
-    for (string s; linestream >> s;) values.push_back(s);
-    if (values.size() > 21)
-      return UpTime() - stol(values[21]) / sysconf(_SC_CLK_TCK);
-  }
-  return 0;
+  return users;
 }
 }  // namespace LinuxParser
 
@@ -243,464 +332,1287 @@ class Processor {
 };
 
 // -----------------------------------------------------------------------------
-// Process
+// Pressure
 // -----------------------------------------------------------------------------
-class Process {
+// Pressure stall information from /proc/pressure/{cpu,memory,io}. Like
+// Processor, it remembers the previous cumulative stall totals so each
+// Update() also yields the share of the last interval that was stalled.
+class Pressure {
  public:
-  int Pid() const { return pid_; }
-  string User() const { return user_; }
-  string Command() const { return command_; }
-  string Ram() const { return ram_; }
-  long UpTime() const { return uptime_; }
-  float CpuUtilization() const { return cpu_; }
-  bool operator>(Process const& a) const { return cpu_ > a.cpu_; }
-
-  void Pid(int pid) { pid_ = pid; }
-  void User(int pid) { user_ = LinuxParser::User(pid); }
-  void Command(int pid) { command_ = LinuxParser::Command(pid); }
-  void Ram(int pid) {
-    string val = LinuxParser::Ram(pid);
-    ram_ = (val == "n/a" ? "0" : to_string(stol(val) / 1024));
-  }
-  void UpTime(int pid) { uptime_ = LinuxParser::UpTime(pid); }
-  void CpuUtilization(int pid) {
-    long total = LinuxParser::ActiveJiffies(pid);
-    long seconds = LinuxParser::UpTime() - LinuxParser::UpTime(pid);
-    cpu_ = seconds ? ((float)(total / sysconf(_SC_CLK_TCK)) / seconds) : 0.0;
+  enum Resource { kCpu, kMemory, kIo, kResources };
+  struct Stall {
+    bool available{false};
+    float someAvg10{0}, fullAvg10{0};        // kernel 10 s averages, percent
+    float someInterval{0}, fullInterval{0};  // percent of the last interval
+    long long someTotal{0}, fullTotal{0};    // cumulative stall time, us
+  };
+
+  void Update() {
+    static const string paths[kResources] = {kPressureDirectory + "cpu", kPressureDirectory + "memory",
+                                             kPressureDirectory + "io"};
+    auto now = std::chrono::steady_clock::now();
+    double elapsedUs = std::chrono::duration<double, std::micro>(now - updated_).count();
+    bool first = updated_ == std::chrono::steady_clock::time_point{};
+    updated_ = now;
+    for (int r = 0; r < kResources; ++r) {
+      Stall& stall = stalls_[r];
+      Stall prev = stall;
+      stall = Stall{};
+      if (LinuxParser::ReadFile(paths[r].c_str(), buf_, sizeof(buf_)) <= 0) continue;
+      stall.available = Parse(strstr(buf_, "some "), stall.someAvg10, stall.someTotal);
+      Parse(strstr(buf_, "full "), stall.fullAvg10, stall.fullTotal);
+      if (first || !prev.available || elapsedUs <= 0) continue;
+      stall.someInterval = 100.0 * (stall.someTotal - prev.someTotal) / elapsedUs;
+      stall.fullInterval = 100.0 * (stall.fullTotal - prev.fullTotal) / elapsedUs;
+    }
   }
+  Stall const& operator[](Resource resource) const { return stalls_[resource]; }
 
  private:
-  int pid_;
-  string user_, command_, ram_;
-  long uptime_;
-  float cpu_;
+  // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+  static bool Parse(char const* line, float& avg10, long long& total) {
+    if (!line) return false;
+    char const* end = strchr(line, '\n');
+    char const* avg = strstr(line, "avg10=");
+    char const* sum = strstr(line, "total=");
+    if (!avg || !sum || (end && (avg > end || sum > end))) return false;
+    avg10 = strtof(avg + 6, nullptr);
+    total = strtoll(sum + 6, nullptr, 10);
+    return true;
+  }
+
+  Stall stalls_[kResources];
+  std::chrono::steady_clock::time_point updated_;
+  char buf_[256];
 };
 
 // -----------------------------------------------------------------------------
-// System
+// StringArena
 // -----------------------------------------------------------------------------
-class System {
+// Per-tick string storage. Interned strings are appended to one buffer and
+// deduplicated through an open-addressing table; Reset() drops them in bulk
+// but keeps the capacity, so a steady-state tick does not allocate.
+class StringArena {
  public:
-  Processor& Cpu() { return cpu_; }
-  vector<Process>& Processes() {
-    vector<int> pids = LinuxParser::Pids();
-    processes_.clear();
-    for (int pid : pids) {
-      Process p;
-      p.Pid(pid);
-      p.User(pid);
-      p.Command(pid);
-      p.CpuUtilization(pid);
-      p.Ram(pid);
-      p.UpTime(pid);
-      processes_.push_back(p);
-    }
-    std::sort(processes_.begin(), processes_.end(), std::greater<Process>());
-    if (processes_.size() > 50) processes_.resize(50);
-    return processes_;
+  using Id = uint32_t;
+
+  void Reset() {
+    bytes_.clear();
+    refs_.clear();
+    std::fill(slots_.begin(), slots_.end(), kEmpty);
+  }
+  Id Intern(std::string_view s) {
+    if ((refs_.size() + 1) * 2 > slots_.size()) Grow();
+    size_t mask = slots_.size() - 1;
+    for (size_t i = std::hash<std::string_view>{}(s) & mask;; i = (i + 1) & mask) {
+      if (slots_[i] == kEmpty) {
+        slots_[i] = refs_.size();
+        refs_.push_back({static_cast<uint32_t>(bytes_.size()), static_cast<uint32_t>(s.size())});
+        bytes_.insert(bytes_.end(), s.begin(), s.end());
+        return slots_[i];
+      }
+      if (View(slots_[i]) == s) return slots_[i];
+    }
+  }
+  std::string_view View(Id id) const {
+    return {bytes_.data() + refs_[id].offset, refs_[id].length};
   }
-  string Kernel() { return LinuxParser::Kernel(); }
-  string OperatingSystem() { return LinuxParser::OperatingSystem(); }
-  float MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
-  int RunningProcesses() { return LinuxParser::RunningProcesses(); }
-  int TotalProcesses() { return LinuxParser::TotalProcesses(); }
-  long UpTime() { return LinuxParser::UpTime(); }
 
  private:
-  Processor cpu_;
-  vector<Process> processes_;
+  static constexpr Id kEmpty = static_cast<Id>(-1);
+  struct Ref {
+    uint32_t offset, length;
+  };
+
+  void Grow() {
+    slots_.assign(std::max<size_t>(256, slots_.size() * 2), kEmpty);
+    size_t mask = slots_.size() - 1;
+    for (Id id = 0; id < refs_.size(); ++id) {
+      size_t i = std::hash<std::string_view>{}(View(id)) & mask;
+      while (slots_[i] != kEmpty) i = (i + 1) & mask;
+      slots_[i] = id;
+    }
+  }
+
+  vector<char> bytes_;
+  vector<Ref> refs_;
+  vector<Id> slots_;
 };
 
 // -----------------------------------------------------------------------------
-// Ncurses Display
+// PidIndex
 // -----------------------------------------------------------------------------
-namespace NCursesDisplay {
-string ProgressBar(float percent) {
-  string bar;
-  int size = 50;
-  int filled = percent * size;
-  for (int i = 0; i < size; ++i)
-    bar += (i < filled ? '|' : ' ');
-  std::ostringstream out;
-  out << " " << std::setw(4) << std::fixed << std::setprecision(1) << percent * 100 << "%";
-  return bar + out.str();
-}
-
-void DisplaySystem(System& system, WINDOW* window) {
-  int row = 0;
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(window, ++row, 2, "CPU: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, ProgressBar(system.Cpu().Utilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, "Memory: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, ProgressBar(system.MemoryUtilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(window, ++row, 2, ("Running: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2, ("Uptime: " + ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
-}
-
-void DisplayProcesses(vector<Process>& procs, WINDOW* window) {
-  int row = 0;
-  wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, 2, "PID      USER        CPU%%   RAM(MB)  TIME     COMMAND");
-  wattroff(window, COLOR_PAIR(2));
-  for (size_t i = 0; i < procs.size() && i < 20; ++i) {
-    mvwprintw(window, ++row, 2, "%d", procs[i].Pid());
-    mvwprintw(window, row, 11, "%s", procs[i].User().c_str());
-    mvwprintw(window, row, 24, "%.1f", procs[i].CpuUtilization() * 100);
-    mvwprintw(window, row, 33, "%s", procs[i].Ram().c_str());
-    mvwprintw(window, row, 43, "%s", ElapsedTime(procs[i].UpTime()).c_str());
-    mvwprintw(window, row, 55, "%s", procs[i].Command().substr(0, getmaxx(window) - 55).c_str());
+// Open-addressing pid -> slot map that is cleared in place each tick.
+class PidIndex {
+ public:
+  static constexpr uint32_t kNone = static_cast<uint32_t>(-1);
+
+  void Reset(size_t n) {
+    size_t capacity = 256;
+    while (capacity < 2 * n) capacity *= 2;
+    if (keys_.size() < capacity) {
+      keys_.resize(capacity);
+      values_.resize(capacity);
+    }
+    std::fill(keys_.begin(), keys_.end(), kEmpty);
+  }
+  void Insert(int pid, uint32_t value) {
+    size_t i = Probe(pid);
+    keys_[i] = pid;
+    values_[i] = value;
+  }
+  uint32_t Find(int pid) const {
+    if (keys_.empty()) return kNone;
+    size_t i = Probe(pid);
+    return keys_[i] == pid ? values_[i] : kNone;
   }
-  wrefresh(window);
-}
 
-void Display(System& system) {
-  initscr(); noecho(); cbreak(); start_color(); nodelay(stdscr, TRUE);
-  curs_set(0); init_pair(1, COLOR_BLUE, COLOR_BLACK); init_pair(2, COLOR_GREEN, COLOR_BLACK);
-  int x_max = getmaxx(stdscr);
-  WINDOW* syswin = newwin(10, x_max - 1, 0, 0);
-  WINDOW* procwin = newwin(25, x_max - 1, 11, 0);
+ private:
+  static constexpr int kEmpty = -1;
 
-  while (true) {
-    werase(syswin); werase(procwin);
-    box(syswin, 0, 0); box(procwin, 0, 0);
-    DisplaySystem(system, syswin);
-    DisplayProcesses(system.Processes(), procwin);
-    wrefresh(syswin); wrefresh(procwin); refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    int ch = getch();
-    if (ch == 'q' || ch == 'Q') break;
+  size_t Probe(int pid) const {
+    size_t mask = keys_.size() - 1;
+    size_t i = (static_cast<uint32_t>(pid) * 2654435761u) & mask;
+    while (keys_[i] != kEmpty && keys_[i] != pid) i = (i + 1) & mask;
+    return i;
   }
 
-  delwin(syswin); delwin(procwin); endwin();
-}
-}  // namespace NCursesDisplay
+  vector<int> keys_;
+  vector<uint32_t> values_;
+};
 
 // -----------------------------------------------------------------------------
-// main()
+// ProcessStore
 // -----------------------------------------------------------------------------
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-  return 0;
-}
-#include <unistd.h>
-#include <dirent.h>
-#include <cctype>
-#include <sstream>
-#include <fstream>
-#include <algorithm>
-#include <thread>
-#include <chrono>
-#include <string>
-#include <vector>
-#include <iostream>
-#include <iomanip>
-#include <ncurses.h>
+// Structure-of-arrays process table refreshed in place every tick. Numeric
+// fields are parsed straight out of /proc/[pid]/stat and schedstat, the real
+// uid from the Uid: line of status, and user/command strings are interned
+// into a per-tick arena. The uid -> name table is reloaded whenever
+// /etc/passwd changes. Columns are cleared, not freed, between
+// ticks; the previous tick's run-queue wait totals are kept to form deltas.
+class ProcessStore {
+ public:
+  ProcessStore()
+      : dir_(opendir(kProcDirectory.c_str())), hz_(sysconf(_SC_CLK_TCK)) {}
+  ~ProcessStore() {
+    if (dir_) closedir(dir_);
+  }
+  ProcessStore(ProcessStore const&) = delete;
+  ProcessStore& operator=(ProcessStore const&) = delete;
+
+  void Collect() {
+    auto now = std::chrono::steady_clock::now();
+    interval_ = std::chrono::duration<double>(now - collected_).count();
+    collected_ = now;
+    prevIndex_.Reset(pid_.size());
+    for (size_t i = 0; i < pid_.size(); ++i) prevIndex_.Insert(pid_[i], i);
+    prevWait_.swap(wait_);
+    prevStart_.swap(start_);
+
+    RefreshUsers();
+    strings_.Reset();
+    pid_.clear(); ppid_.clear(); jiffies_.clear(); rss_.clear(); start_.clear();
+    wait_.clear(); cpu_.clear(); waitRate_.clear(); user_.clear(); command_.clear();
+    static const string uptimePath = kProcDirectory + kUptimeFilename;
+    uptime_ = 0;
+    if (LinuxParser::ReadFile(uptimePath.c_str(), buf_, sizeof(buf_)) > 0)
+      uptime_ = strtol(buf_, nullptr, 10);
+    if (!dir_) return;
+    rewinddir(dir_);
+    for (dirent* file; (file = readdir(dir_)) != nullptr;) {
+      if (file->d_type != DT_DIR || !isdigit(file->d_name[0])) continue;
+      char* end;
+      long pid = strtol(file->d_name, &end, 10);
+      if (*end == '\0') Read(static_cast<int>(pid));
+    }
+  }
 
-using std::string;
-using std::vector;
-using std::to_string;
+  size_t Size() const { return pid_.size(); }
+  long Hz() const { return hz_; }
+  int Pid(size_t i) const { return pid_[i]; }
+  int Ppid(size_t i) const { return ppid_[i]; }
+  long Jiffies(size_t i) const { return jiffies_[i]; }
+  long RssKb(size_t i) const { return rss_[i]; }
+  long StartTime(size_t i) const { return start_[i]; }
+  long UpTime(size_t i) const { return uptime_ - start_[i] / hz_; }
+  long WaitNs(size_t i) const { return wait_[i]; }
+  float CpuUtilization(size_t i) const { return cpu_[i]; }
+  // Milliseconds per second spent runnable but waiting for a CPU, measured
+  // over the interval since the previous Collect().
+  float WaitRate(size_t i) const { return waitRate_[i]; }
+  std::string_view User(size_t i) const { return strings_.View(user_[i]); }
+  std::string_view Command(size_t i) const { return strings_.View(command_[i]); }
 
-// -----------------------------------------------------------------------------
-// Constants
-// -----------------------------------------------------------------------------
-const string kProcDirectory{"/proc/"};
-const string kVersionFilename{"/version"};
-const string kMeminfoFilename{"/meminfo"};
-const string kUptimeFilename{"/uptime"};
-const string kStatFilename{"/stat"};
-const string kCmdlineFilename{"/cmdline"};
-const string kStatusFilename{"/status"};
-const string kOSPath{"/etc/os-release"};
-const string kPasswordPath{"/etc/passwd"};
+ private:
+  // Users created while the monitor runs appear once passwd is rewritten.
+  void RefreshUsers() {
+    struct stat info;
+    if (stat(kPasswordPath.c_str(), &info) != 0) return;
+    if (info.st_mtim.tv_sec == usersMtime_.tv_sec && info.st_mtim.tv_nsec == usersMtime_.tv_nsec) return;
+    usersMtime_ = info.st_mtim;
+    users_ = LinuxParser::UserNames();
+  }
+
+  // A process that exits between readdir() and the reads is skipped.
+  void Read(int pid) {
+    LinuxParser::StatFields fields;
+    snprintf(path_, sizeof(path_), "/proc/%d/stat", pid);
+    if (LinuxParser::ReadFile(path_, buf_, sizeof(buf_)) <= 0 || !fields.Parse(buf_)) return;
+    long jiffies = fields.Jiffies();
+    long start = fields[22];
+    long rssPages = fields[24];
+
+    // Not the owner of /proc/[pid]: the kernel makes that root for
+    // non-dumpable processes such as setuid programs.
+    LinuxParser::ProcessOwner owner;
+    snprintf(path_, sizeof(path_), "/proc/%d/status", pid);
+    if (!LinuxParser::ParseKeys<LinuxParser::kProcessOwnerKeys>(path_, owner)) return;
+    auto user = users_.find(owner.uid);
+
+    snprintf(path_, sizeof(path_), "/proc/%d/cmdline", pid);
+    long length = LinuxParser::ReadFile(path_, buf_, sizeof(buf_));
+    std::string_view command(buf_, length > 0 ? strlen(buf_) : 0);
+    StringArena::Id commandId = strings_.Intern(command);
+
+    // schedstat: time on cpu, time waiting on a run queue (ns), timeslices.
+    long wait = 0;
+    snprintf(path_, sizeof(path_), "/proc/%d/schedstat", pid);
+    if (LinuxParser::ReadFile(path_, buf_, sizeof(buf_)) > 0) {
+      char* p;
+      strtol(buf_, &p, 10);
+      wait = strtol(p, nullptr, 10);
+    }
+    uint32_t prev = prevIndex_.Find(pid);
+    bool known = prev != PidIndex::kNone && prevStart_[prev] == start && interval_ > 0;
+
+    long seconds = uptime_ - start / hz_;
+    pid_.push_back(pid);
+    ppid_.push_back(static_cast<int>(fields[4]));
+    jiffies_.push_back(jiffies);
+    rss_.push_back(rssPages * pageKb_);
+    start_.push_back(start);
+    wait_.push_back(wait);
+    waitRate_.push_back(known ? (wait - prevWait_[prev]) / 1e6 / interval_ : 0.0f);
+    cpu_.push_back(seconds > 0 ? static_cast<float>(jiffies) / hz_ / seconds : 0.0f);
+    user_.push_back(strings_.Intern(user != users_.end() ? user->second : "n/a"));
+    command_.push_back(commandId);
+  }
+
+  DIR* dir_;
+  long hz_;
+  long pageKb_{sysconf(_SC_PAGESIZE) / 1024};
+  long uptime_{0};
+  std::unordered_map<int, string> users_;
+  timespec usersMtime_{};
+  char path_[64];
+  char buf_[4096];
+  vector<int> pid_, ppid_;
+  vector<long> jiffies_, rss_, start_, wait_;
+  vector<float> cpu_, waitRate_;
+  vector<StringArena::Id> user_, command_;
+  StringArena strings_;
+  PidIndex prevIndex_;
+  vector<long> prevWait_, prevStart_;
+  std::chrono::steady_clock::time_point collected_;
+  double interval_{0};
+};
 
 // -----------------------------------------------------------------------------
-// Helper: Format elapsed time
+// Process
 // -----------------------------------------------------------------------------
-string ElapsedTime(long seconds) {
-  int h = seconds / 3600;
-  int m = (seconds % 3600) / 60;
-  int s = seconds % 60;
-  std::ostringstream out;
-  out << std::setw(2) << std::setfill('0') << h << ":"
-      << std::setw(2) << std::setfill('0') << m << ":"
-      << std::setw(2) << std::setfill('0') << s;
-  return out.str();
-}
+// Lightweight view of one row of the ProcessStore, valid until the next tick.
+class Process {
+ public:
+  Process(ProcessStore const& store, size_t slot) : store_(&store), slot_(slot) {}
+  int Pid() const { return store_->Pid(slot_); }
+  int Ppid() const { return store_->Ppid(slot_); }
+  std::string_view User() const { return store_->User(slot_); }
+  std::string_view Command() const { return store_->Command(slot_); }
+  long Ram() const { return store_->RssKb(slot_) / 1024; }
+  long UpTime() const { return store_->UpTime(slot_); }
+  float CpuUtilization() const { return store_->CpuUtilization(slot_); }
+  float WaitRate() const { return store_->WaitRate(slot_); }
+
+ private:
+  ProcessStore const* store_;
+  size_t slot_;
+};
 
 // -----------------------------------------------------------------------------
-// LinuxParser namespace
+// ProcessTree
 // -----------------------------------------------------------------------------
-namespace LinuxParser {
-string KeyValParser(string key, string path) {
-  string value = "n/a", temp, line;
-  std::ifstream stream(path);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> temp;
-      if (temp == key) {
-        linestream >> value;
-        break;
+// Parent/child index rebuilt in O(n) per tick: one hash pass maps pids to
+// slots, children are laid out contiguously (CSR), and a single preorder walk
+// gives depths while its reverse gives the subtree rollups.
+class ProcessTree {
+ public:
+  struct Row {
+    size_t node;
+    int depth;
+  };
+
+  void Build(ProcessStore const& store) {
+    store_ = &store;
+    size_t n = store.Size();
+    index_.Reset(n);
+    for (size_t i = 0; i < n; ++i) index_.Insert(store.Pid(i), i);
+
+    parent_.assign(n, kNone);
+    childStart_.assign(n + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t parent = index_.Find(store.Ppid(i));
+      if (parent != PidIndex::kNone && parent != i) {
+        parent_[i] = parent;
+        ++childStart_[parent + 1];
       }
     }
-  }
-  return value;
-}
-
-string OperatingSystem() {
-  string line, key, value = "n/a";
-  std::ifstream filestream(kOSPath);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::replace(line.begin(), line.end(), ' ', '_');
-      std::replace(line.begin(), line.end(), '=', ' ');
-      std::replace(line.begin(), line.end(), '"', ' ');
-      std::istringstream linestream(line);
-      while (linestream >> key >> value) {
-        if (key == "PRETTY_NAME") {
-          std::replace(value.begin(), value.end(), '_', ' ');
-          return value;
-        }
+    for (size_t i = 0; i < n; ++i) childStart_[i + 1] += childStart_[i];
+    children_.resize(n);
+    cursor_.assign(childStart_.begin(), childStart_.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+      if (parent_[i] != kNone) children_[cursor_[parent_[i]]++] = i;
+
+    // Preorder walk from the roots; nodes caught in a ppid cycle are never
+    // reached and simply drop out of the view.
+    order_.clear();
+    depth_.assign(n, 0);
+    stack_.clear();
+    for (size_t r = n; r-- > 0;)
+      if (parent_[r] == kNone) stack_.push_back(r);
+    while (!stack_.empty()) {
+      size_t node = stack_.back();
+      stack_.pop_back();
+      order_.push_back(node);
+      for (size_t c = childStart_[node + 1]; c-- > childStart_[node];) {
+        depth_[children_[c]] = depth_[node] + 1;
+        stack_.push_back(children_[c]);
       }
     }
-  }
-  return value;
-}
 
-string Kernel() {
-  string os, version, kernel;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
-  if (stream.is_open()) {
-    stream >> os >> version >> kernel;
+    subtreeCpu_.assign(n, 0.0);
+    subtreeRam_.assign(n, 0);
+    subtreeSize_.assign(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+      subtreeCpu_[i] = store.CpuUtilization(i);
+      subtreeRam_[i] = store.RssKb(i);
+    }
+    for (size_t k = order_.size(); k-- > 0;) {
+      size_t node = order_[k], parent = parent_[node];
+      if (parent == kNone) continue;
+      subtreeCpu_[parent] += subtreeCpu_[node];
+      subtreeRam_[parent] += subtreeRam_[node];
+      subtreeSize_[parent] += subtreeSize_[node];
+    }
+    // Forget collapsed pids that have exited so a reused pid starts expanded.
+    for (auto it = collapsed_.begin(); it != collapsed_.end();)
+      it = index_.Find(*it) == PidIndex::kNone ? collapsed_.erase(it) : std::next(it);
+    Flatten();
   }
-  return kernel;
-}
 
-vector<int> Pids() {
-  vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    if (file->d_type == DT_DIR) {
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        pids.push_back(stoi(filename));
-      }
-    }
+  vector<Row> const& Rows() const { return rows_; }
+  Process At(size_t node) const { return Process(*store_, node); }
+  float SubtreeCpu(size_t node) const { return subtreeCpu_[node]; }
+  long SubtreeRam(size_t node) const { return subtreeRam_[node] / 1024; }
+  bool HasChildren(size_t node) const {
+    return childStart_[node + 1] > childStart_[node];
+  }
+  bool Collapsed(size_t node) const {
+    return collapsed_.count(store_->Pid(node)) > 0;
+  }
+  void Toggle(int pid) {
+    if (!collapsed_.erase(pid)) collapsed_.insert(pid);
+    Flatten();
   }
-  closedir(directory);
-  return pids;
-}
 
-vector<string> CpuUtilization() {
-  vector<string> values;
-  string line, key, val;
-  std::ifstream stream(kProcDirectory + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    linestream >> key;
-    for (int i = 0; i < 10; ++i) {
-      linestream >> val;
-      values.push_back(val);
+ private:
+  static constexpr size_t kNone = static_cast<size_t>(-1);
+
+  // A subtree is contiguous in preorder, so collapsing skips it in one step.
+  void Flatten() {
+    rows_.clear();
+    for (size_t k = 0; k < order_.size(); ++k) {
+      size_t node = order_[k];
+      rows_.push_back({node, depth_[node]});
+      if (Collapsed(node)) k += subtreeSize_[node] - 1;
     }
   }
-  return values;
-}
 
-float MemoryUtilization() {
-  string memTotalStr = KeyValParser("MemTotal:", kProcDirectory + kMeminfoFilename);
-  string memFreeStr = KeyValParser("MemFree:", kProcDirectory + kMeminfoFilename);
-  float memTotal = std::stof(memTotalStr);
-  float memFree = std::stof(memFreeStr);
-  return (memTotal - memFree) / memTotal;
-}
+  ProcessStore const* store_{nullptr};
+  PidIndex index_;
+  vector<size_t> parent_, childStart_, children_, cursor_, stack_, order_, subtreeSize_;
+  vector<int> depth_;
+  vector<float> subtreeCpu_;
+  vector<long> subtreeRam_;
+  std::unordered_set<int> collapsed_;
+  vector<Row> rows_;
+};
 
-long UpTime() {
-  long uptime = 0;
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
-  if (stream.is_open()) {
-    stream >> uptime;
+// -----------------------------------------------------------------------------
+// System
+// -----------------------------------------------------------------------------
+class System {
+ public:
+  enum class SortKey { kCpu, kWait };
+
+  Processor& Cpu() { return cpu_; }
+  Pressure& Stalls() { return pressure_; }
+  ProcessTree& Tree() { return tree_; }
+  ProcessStore const& Store() const { return store_; }
+  vector<Process>& Processes() {
+    store_.Collect();
+    tree_.Build(store_);
+    Sort();
+    return processes_;
   }
-  return uptime;
-}
+  // The list from the last Processes() call, without collecting again.
+  vector<Process>& Listed() { return processes_; }
+  SortKey SortedBy() const { return sortKey_; }
+  void SortBy(SortKey key) {
+    sortKey_ = key;
+    Sort();
+  }
+  string Kernel() { return LinuxParser::Kernel(); }
+  string OperatingSystem() { return LinuxParser::OperatingSystem(); }
+  float MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+  LinuxParser::ProcessTotals ProcessCounts() { return LinuxParser::ProcessCounts(); }
+  long UpTime() { return LinuxParser::UpTime(); }
 
-int TotalProcesses() {
-  return stoi(KeyValParser("processes", kProcDirectory + kStatFilename));
-}
+ private:
+  void Sort() {
+    order_.resize(store_.Size());
+    std::iota(order_.begin(), order_.end(), 0);
+    size_t top = std::min<size_t>(order_.size(), 50);
+    auto key = [this](size_t i) {
+      return sortKey_ == SortKey::kWait ? store_.WaitRate(i) : store_.CpuUtilization(i);
+    };
+    std::partial_sort(order_.begin(), order_.begin() + top, order_.end(),
+                      [&key](size_t a, size_t b) { return key(a) > key(b); });
+    processes_.clear();
+    for (size_t i = 0; i < top; ++i) processes_.emplace_back(store_, order_[i]);
+  }
 
-int RunningProcesses() {
-  return stoi(KeyValParser("procs_running", kProcDirectory + kStatFilename));
-}
+  Processor cpu_;
+  Pressure pressure_;
+  SortKey sortKey_{SortKey::kCpu};
+  ProcessStore store_;
+  vector<size_t> order_;
+  vector<Process> processes_;
+  ProcessTree tree_;
+};
 
-long Jiffies() {
-  auto cpu = CpuUtilization();
-  long total = 0;
-  for (auto& s : cpu) total += stol(s);
-  return total;
-}
+// -----------------------------------------------------------------------------
+// Sampler
+// -----------------------------------------------------------------------------
+// Allocation-free readers for the few counters the alert engine watches,
+// cheap enough to run at 10 Hz: the aggregate cpu line of /proc/stat, the
+// head of /proc/meminfo and individual /proc/[pid]/stat files.
+class Sampler {
+ public:
+  struct SystemSample {
+    long active{0}, total{0};
+    float mem{0};
+  };
+
+  bool System(SystemSample& sample) {
+    static const string statPath = kProcDirectory + kStatFilename;
+    static const string meminfoPath = kProcDirectory + kMeminfoFilename;
+    // Only the first line matters: "cpu user nice system idle iowait ..."
+    if (LinuxParser::ReadFile(statPath.c_str(), buf_, 512) <= 0 || strncmp(buf_, "cpu ", 4) != 0)
+      return false;
+    char* p = buf_ + 4;
+    long cpu[10];
+    for (long& value : cpu) value = strtol(p, &p, 10);
+    sample.active = cpu[0] + cpu[1] + cpu[2] + cpu[5] + cpu[6] + cpu[7];
+    sample.total = std::accumulate(cpu, cpu + 10, 0L);
+
+    LinuxParser::MemInfo info;
+    if (!LinuxParser::ParseKeys<LinuxParser::kMemInfoKeys>(meminfoPath.c_str(), info)) return false;
+    sample.mem = info.total > 0 ? static_cast<float>(info.total - info.free) / info.total : 0;
+    return true;
+  }
 
-long ActiveJiffies() {
-  auto cpu = CpuUtilization();
-  return stol(cpu[0]) + stol(cpu[1]) + stol(cpu[2]) + stol(cpu[5]) + stol(cpu[6]) + stol(cpu[7]);
-}
+  bool Process(int pid, long& jiffies, long& rssKb) {
+    LinuxParser::StatFields fields;
+    snprintf(path_, sizeof(path_), "/proc/%d/stat", pid);
+    if (LinuxParser::ReadFile(path_, buf_, sizeof(buf_)) <= 0 || !fields.Parse(buf_)) return false;
+    jiffies = fields.Jiffies();
+    rssKb = fields[24] * pageKb_;
+    return true;
+  }
 
-long IdleJiffies() {
-  auto cpu = CpuUtilization();
-  return stol(cpu[3]) + stol(cpu[4]);
-}
+ private:
+  long pageKb_{sysconf(_SC_PAGESIZE) / 1024};
+  char path_[64];
+  char buf_[1024];
+};
 
-string Uid(int pid) {
-  return KeyValParser("Uid:", kProcDirectory + to_string(pid) + kStatusFilename);
-}
+// -----------------------------------------------------------------------------
+// Alerts
+// -----------------------------------------------------------------------------
+struct AlertRule {
+  enum Metric { kSystemCpu, kSystemMem, kProcessCpu, kRssGrowth };
+
+  Metric metric;
+  double threshold;  // percent, or MB/s for kRssGrowth
+  double seconds;    // how long the threshold must be exceeded before firing
+  string spec;
+
+  bool PerProcess() const { return metric == kProcessCpu || metric == kRssGrowth; }
+
+  // "METRIC>THRESHOLD[:SECONDS]" where METRIC is cpu, mem (system percent),
+  // pcpu (per-process percent) or rss_rate (per-process MB/s),
+  // e.g. "cpu>90:3" or "rss_rate>100".
+  static bool Parse(string const& spec, AlertRule& rule) {
+    size_t gt = spec.find('>');
+    if (gt == string::npos) return false;
+    string name = spec.substr(0, gt);
+    if (name == "cpu") rule.metric = kSystemCpu;
+    else if (name == "mem") rule.metric = kSystemMem;
+    else if (name == "pcpu") rule.metric = kProcessCpu;
+    else if (name == "rss_rate") rule.metric = kRssGrowth;
+    else return false;
+    char const* p = spec.c_str() + gt + 1;
+    char* end;
+    rule.threshold = strtod(p, &end);
+    if (end == p) return false;
+    rule.seconds = 0;
+    if (*end == ':') {
+      p = end + 1;
+      rule.seconds = strtod(p, &end);
+      if (end == p || rule.seconds < 0) return false;
+      if (*end == 's') ++end;
+    }
+    rule.spec = spec;
+    return *end == '\0';
+  }
+};
 
-string User(int pid) {
-  string uid = Uid(pid), line, user, x, id;
-  std::ifstream stream(kPasswordPath);
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      std::istringstream linestream(line);
-      linestream >> user >> x >> id;
-      if (id == uid) return user;
+// Evaluates the rules on every sample. A rule fires once its metric stays
+// above the threshold for the configured time and clears only after it drops
+// below the threshold minus a hysteresis band. Firing switches sampling to a
+// short burst at kBurstInterval, limited to the offending processes (or the
+// hottest ones for a system rule), and appends the burst to a capture file.
+class AlertEngine {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  AlertEngine(vector<AlertRule> rules, string capturePath)
+      : rules_(std::move(rules)), capturePath_(std::move(capturePath)), hz_(sysconf(_SC_CLK_TCK)) {}
+  ~AlertEngine() { EndBurst(); }
+  AlertEngine(AlertEngine const&) = delete;
+  AlertEngine& operator=(AlertEngine const&) = delete;
+
+  bool Enabled() const { return !rules_.empty(); }
+  bool Bursting() const { return Clock::now() < burstEnd_; }
+  Clock::duration Interval() const {
+    return Bursting() ? Clock::duration(kBurstInterval) : Clock::duration(std::chrono::seconds(1));
+  }
+
+  // Regular tick over the whole process table collected for the display.
+  void Tick(ProcessStore const& store) {
+    if (!Enabled()) return;
+    auto now = Clock::now();
+    double dt = std::chrono::duration<double>(now - prevTick_).count();
+    // Rank the hot set before system rules run so a burst they start can
+    // watch it. Processes without a previous sample (the first tick, or new
+    // since the last one) rank by their lifetime CPU share instead.
+    hot_.clear();
+    for (size_t i = 0; i < store.Size(); ++i) {
+      uint32_t j = prevPid_.empty() ? PidIndex::kNone : prevIndex_.Find(store.Pid(i));
+      double cpu = 100.0 * store.CpuUtilization(i);
+      if (j != PidIndex::kNone && prevStart_[j] == store.StartTime(i)) {
+        cpu = 100.0 * (store.Jiffies(i) - prevJiffies_[j]) / hz_ / dt;
+        double rssRate = (store.RssKb(i) - prevRss_[j]) / 1024.0 / dt;
+        ObserveProcess(store.Pid(i), cpu, rssRate, now);
+      }
+      hot_.emplace_back(cpu, store.Pid(i));
+    }
+    size_t hot = std::min(hot_.size(), kHotProcesses);
+    std::partial_sort(hot_.begin(), hot_.begin() + hot, hot_.end(), std::greater<>());
+    hot_.resize(hot);
+
+    prevPid_.clear(); prevJiffies_.clear(); prevRss_.clear(); prevStart_.clear();
+    prevIndex_.Reset(store.Size());
+    for (size_t i = 0; i < store.Size(); ++i) {
+      prevIndex_.Insert(store.Pid(i), i);
+      prevPid_.push_back(store.Pid(i));
+      prevJiffies_.push_back(store.Jiffies(i));
+      prevRss_.push_back(store.RssKb(i));
+      prevStart_.push_back(store.StartTime(i));
     }
+    prevTick_ = now;
+    SampleSystem(now);
+    // Forget processes that have exited.
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                                 [this](Track const& t) {
+                                   return t.pid && prevIndex_.Find(t.pid) == PidIndex::kNone;
+                                 }),
+                  tracks_.end());
+    if (Bursting()) SampleWatched(now);
+    if (capture_ && !Bursting()) EndBurst();
   }
-  return "n/a";
-}
 
-string Command(int pid) {
-  string line;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kCmdlineFilename);
-  if (stream.is_open()) std::getline(stream, line);
-  return line;
-}
+  // Burst sample between ticks: system counters and watched pids only.
+  void BurstSample() {
+    auto now = Clock::now();
+    if (!Bursting()) {
+      EndBurst();
+      return;
+    }
+    SampleSystem(now);
+    SampleWatched(now);
+  }
 
-string Ram(int pid) {
-  return KeyValParser("VmSize:", kProcDirectory + to_string(pid) + kStatusFilename);
-}
+  string Status() const {
+    string firing;
+    for (Track const& t : tracks_) {
+      if (!t.firing) continue;
+      firing += (firing.empty() ? "" : ", ") + rules_[t.rule].spec;
+      if (t.pid) firing += " (pid " + to_string(t.pid) + ")";
+    }
+    string status = to_string(rules_.size()) + " rule(s), " + (firing.empty() ? "quiet" : "FIRING " + firing);
+    if (Bursting()) {
+      long left = std::chrono::duration_cast<std::chrono::seconds>(burstEnd_ - Clock::now()).count();
+      status += " | burst: " + to_string(watched_.size()) + " pid(s), " + to_string(left) + "s left -> " + capturePath_;
+    }
+    return status;
+  }
 
-long ActiveJiffies(int pid) {
-  string line, value;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    vector<string> values;
-    for (string s; linestream >> s;) values.push_back(s);
-    if (values.size() > 16)
-      return stol(values[13]) + stol(values[14]) + stol(values[15]) + stol(values[16]);
+ private:
+  static constexpr std::chrono::milliseconds kBurstInterval{100};
+  static constexpr std::chrono::seconds kBurstLength{30};
+  static constexpr double kHysteresis = 0.1;
+  static constexpr size_t kHotProcesses = 5;
+
+  struct Track {
+    size_t rule;
+    int pid;  // 0 for system rules
+    Clock::time_point since;
+    bool firing;
+  };
+  struct Watch {
+    int pid;
+    long jiffies, rssKb;
+    Clock::time_point at;
+  };
+
+  void SampleSystem(Clock::time_point now) {
+    Sampler::SystemSample sample;
+    if (!sampler_.System(sample)) return;
+    long total = sample.total - lastSystem_.total;
+    if (lastSystem_.total && total > 0) {
+      double cpu = 100.0 * (sample.active - lastSystem_.active) / total;
+      double mem = 100.0 * sample.mem;
+      for (size_t r = 0; r < rules_.size(); ++r) {
+        if (rules_[r].metric == AlertRule::kSystemCpu) Observe(r, 0, cpu, now);
+        if (rules_[r].metric == AlertRule::kSystemMem) Observe(r, 0, mem, now);
+      }
+      if (capture_) fprintf(capture_, "%lld\tsystem\t%.1f\t%.1f\n", WallMs(), cpu, mem);
+    }
+    lastSystem_ = sample;
   }
-  return 0;
-}
 
-long UpTime(int pid) {
-  string line;
-  std::ifstream stream(kProcDirectory + to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    vector<string> values;
-    for (string s; linestream >> s;) values.push_back(s);
-    if (values.size() > 21)
-      return UpTime() - stol(values[21]) / sysconf(_SC_CLK_TCK);
+  void SampleWatched(Clock::time_point now) {
+    for (size_t w = 0; w < watched_.size();) {
+      Watch& watch = watched_[w];
+      long jiffies, rssKb;
+      if (!sampler_.Process(watch.pid, jiffies, rssKb)) {
+        watched_.erase(watched_.begin() + w);
+        continue;
+      }
+      double dt = std::chrono::duration<double>(now - watch.at).count();
+      if (dt > 0) {
+        double cpu = 100.0 * (jiffies - watch.jiffies) / hz_ / dt;
+        double rssRate = (rssKb - watch.rssKb) / 1024.0 / dt;
+        ObserveProcess(watch.pid, cpu, rssRate, now);
+        if (capture_)
+          fprintf(capture_, "%lld\tpid\t%d\t%.1f\t%ld\t%.1f\n", WallMs(), watch.pid, cpu, rssKb, rssRate);
+      }
+      watched_[w] = {watch.pid, jiffies, rssKb, now};
+      ++w;
+    }
+  }
+
+  void ObserveProcess(int pid, double cpu, double rssRate, Clock::time_point now) {
+    for (size_t r = 0; r < rules_.size(); ++r) {
+      if (rules_[r].metric == AlertRule::kProcessCpu) Observe(r, pid, cpu, now);
+      if (rules_[r].metric == AlertRule::kRssGrowth) Observe(r, pid, rssRate, now);
+    }
+  }
+
+  void Observe(size_t rule, int pid, double value, Clock::time_point now) {
+    AlertRule const& r = rules_[rule];
+    auto track = std::find_if(tracks_.begin(), tracks_.end(),
+                              [&](Track const& t) { return t.rule == rule && t.pid == pid; });
+    if (value > r.threshold) {
+      if (track == tracks_.end()) {
+        tracks_.push_back({rule, pid, now, false});
+        track = tracks_.end() - 1;
+      }
+      if (!track->firing && std::chrono::duration<double>(now - track->since).count() >= r.seconds) {
+        track->firing = true;
+        Fire(*track, value, now);
+      }
+    } else if (track != tracks_.end() &&
+               (!track->firing || value < r.threshold - kHysteresis * std::abs(r.threshold))) {
+      if (track->firing && capture_)
+        fprintf(capture_, "# %lld cleared %s pid %d value %.1f\n", WallMs(), r.spec.c_str(), pid, value);
+      tracks_.erase(track);
+    }
+  }
+
+  void Fire(Track const& track, double value, Clock::time_point now) {
+    if (!capture_) {
+      capture_ = fopen(capturePath_.c_str(), "a");
+      if (capture_)
+        fprintf(capture_,
+                "# burst started %lld (every %lld ms)\n"
+                "# columns: ms system cpu%% mem%% | ms pid PID cpu%% rss_kb rss_mb/s\n",
+                WallMs(), static_cast<long long>(kBurstInterval.count()));
+    }
+    if (capture_)
+      fprintf(capture_, "# %lld fired %s pid %d value %.1f\n", WallMs(), rules_[track.rule].spec.c_str(),
+              track.pid, value);
+    burstEnd_ = now + kBurstLength;
+    if (track.pid) {
+      AddWatch(track.pid, now);
+    } else {
+      for (auto const& hot : hot_) AddWatch(hot.second, now);
+    }
+  }
+
+  void AddWatch(int pid, Clock::time_point now) {
+    for (auto const& watch : watched_)
+      if (watch.pid == pid) return;
+    long jiffies, rssKb;
+    if (sampler_.Process(pid, jiffies, rssKb)) watched_.push_back({pid, jiffies, rssKb, now});
   }
-  return 0;
-}
-}  // namespace LinuxParser
+
+  void EndBurst() {
+    watched_.clear();
+    if (!capture_) return;
+    fprintf(capture_, "# burst ended %lld\n", WallMs());
+    fclose(capture_);
+    capture_ = nullptr;
+  }
+
+  static long long WallMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  vector<AlertRule> rules_;
+  string capturePath_;
+  long hz_;
+  FILE* capture_{nullptr};
+  Sampler sampler_;
+  Sampler::SystemSample lastSystem_;
+  PidIndex prevIndex_;
+  vector<int> prevPid_;
+  vector<long> prevJiffies_, prevRss_, prevStart_;
+  Clock::time_point prevTick_, burstEnd_;
+  vector<std::pair<double, int>> hot_;
+  vector<Track> tracks_;
+  vector<Watch> watched_;
+};
 
 // -----------------------------------------------------------------------------
-// Processor
+// Wire format
 // -----------------------------------------------------------------------------
-class Processor {
+// Agents stream length-prefixed frames: a 4-byte little-endian payload size,
+// then a frame type. A kFull frame carries the whole snapshot; every later
+// kDelta frame carries only the system fields and processes that changed,
+// as zigzag varint differences against the previous tick. Processes travel
+// as raw counters (jiffies, start time) rather than derived percentages so
+// that an idle process produces no bytes at all.
+namespace Wire {
+enum FrameType : uint8_t { kFull = 1, kDelta = 2 };
+enum SystemField : uint8_t { kCpu = 1, kMem = 2, kTotal = 4, kRunning = 8, kUptime = 16 };
+enum ProcField : uint8_t {
+  kPpid = 1, kJiffies = 2, kRss = 4, kStart = 8, kUser = 16, kCommand = 32, kAllFields = 63
+};
+const size_t kMaxFrame = 16 << 20;
+// Smallest encodings, used to bound counts read from a frame before any
+// allocation: a full record is seven varints or lengths, a removed pid one
+// gap and a changed record a gap plus its mask.
+const size_t kMinFullRecord = 7, kMinRemoved = 1, kMinChanged = 2;
+
+struct SystemRecord {
+  long cpu{0}, mem{0};  // permille
+  long total{0}, running{0}, uptime{0}, hz{100};
+  string os, kernel;
+};
+
+struct ProcRecord {
+  int pid{0}, ppid{0};
+  long jiffies{0}, rssKb{0}, start{0};
+  string user, command;
+};
+
+// Processes are kept sorted by pid so both sides can diff by merging.
+struct Snapshot {
+  SystemRecord system;
+  vector<ProcRecord> procs;
+};
+
+class Writer {
  public:
-  float Utilization() {
-    long active = LinuxParser::ActiveJiffies();
-    long total = LinuxParser::Jiffies();
-    long deltaActive = active - prevActive_;
-    long deltaTotal = total - prevTotal_;
-    prevActive_ = active;
-    prevTotal_ = total;
-    return deltaTotal ? static_cast<float>(deltaActive) / deltaTotal : 0.0;
+  explicit Writer(vector<uint8_t>& out) : out_(out) {
+    out_.assign(4, 0);
   }
+  void U(uint64_t v) {
+    for (; v >= 0x80; v >>= 7) out_.push_back(static_cast<uint8_t>(v | 0x80));
+    out_.push_back(static_cast<uint8_t>(v));
+  }
+  void S(int64_t v) { U((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+  void Str(string const& s) {
+    U(s.size());
+    out_.insert(out_.end(), s.begin(), s.end());
+  }
+  // Patches the length prefix once the payload is complete.
+  void Finish() {
+    uint32_t size = out_.size() - 4;
+    for (int i = 0; i < 4; ++i) out_[i] = static_cast<uint8_t>(size >> (8 * i));
+  }
+
  private:
-  long prevActive_{0}, prevTotal_{0};
+  vector<uint8_t>& out_;
 };
 
-// -----------------------------------------------------------------------------
-// Process
-// -----------------------------------------------------------------------------
-class Process {
+class Reader {
  public:
-  int Pid() const { return pid_; }
-  string User() const { return user_; }
-  string Command() const { return command_; }
-  string Ram() const { return ram_; }
-  long UpTime() const { return uptime_; }
-  float CpuUtilization() const { return cpu_; }
-  bool operator>(Process const& a) const { return cpu_ > a.cpu_; }
-
-  void Pid(int pid) { pid_ = pid; }
-  void User(int pid) { user_ = LinuxParser::User(pid); }
-  void Command(int pid) { command_ = LinuxParser::Command(pid); }
-  void Ram(int pid) {
-    string val = LinuxParser::Ram(pid);
-    ram_ = (val == "n/a" ? "0" : to_string(stol(val) / 1024));
-  }
-  void UpTime(int pid) { uptime_ = LinuxParser::UpTime(pid); }
-  void CpuUtilization(int pid) {
-    long total = LinuxParser::ActiveJiffies(pid);
-    long seconds = LinuxParser::UpTime() - LinuxParser::UpTime(pid);
-    cpu_ = seconds ? ((float)(total / sysconf(_SC_CLK_TCK)) / seconds) : 0.0;
+  Reader(uint8_t const* data, size_t size) : p_(data), end_(data + size) {}
+  bool Ok() const { return ok_; }
+  size_t Remaining() const { return end_ - p_; }
+  uint64_t U() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (p_ == end_) break;
+      uint8_t byte = *p_++;
+      v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return v;
+    }
+    ok_ = false;
+    return 0;
+  }
+  int64_t S() {
+    uint64_t v = U();
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+  string Str() {
+    uint64_t size = U();
+    if (size > static_cast<uint64_t>(end_ - p_)) {
+      ok_ = false;
+      return "";
+    }
+    string s(reinterpret_cast<char const*>(p_), size);
+    p_ += size;
+    return s;
   }
 
  private:
-  int pid_;
-  string user_, command_, ram_;
-  long uptime_;
-  float cpu_;
+  uint8_t const* p_;
+  uint8_t const* end_;
+  bool ok_{true};
 };
 
+void EncodeFull(Snapshot const& snap, vector<uint8_t>& frame) {
+  Writer w(frame);
+  SystemRecord const& sys = snap.system;
+  w.U(kFull);
+  w.U(sys.cpu); w.U(sys.mem); w.U(sys.total); w.U(sys.running); w.U(sys.uptime); w.U(sys.hz);
+  w.Str(sys.os);
+  w.Str(sys.kernel);
+  w.U(snap.procs.size());
+  int lastPid = 0;
+  for (ProcRecord const& p : snap.procs) {
+    w.U(p.pid - lastPid);
+    w.U(p.ppid); w.U(p.jiffies); w.U(p.rssKb); w.U(p.start);
+    w.Str(p.user);
+    w.Str(p.command);
+    lastPid = p.pid;
+  }
+  w.Finish();
+}
+
+void EncodeDelta(Snapshot const& prev, Snapshot const& next, vector<uint8_t>& frame) {
+  Writer w(frame);
+  SystemRecord const& a = prev.system;
+  SystemRecord const& b = next.system;
+  uint8_t sysMask = (a.cpu != b.cpu ? kCpu : 0) | (a.mem != b.mem ? kMem : 0) |
+                    (a.total != b.total ? kTotal : 0) | (a.running != b.running ? kRunning : 0) |
+                    (a.uptime != b.uptime ? kUptime : 0);
+  w.U(kDelta);
+  w.U(sysMask);
+  if (sysMask & kCpu) w.S(b.cpu - a.cpu);
+  if (sysMask & kMem) w.S(b.mem - a.mem);
+  if (sysMask & kTotal) w.S(b.total - a.total);
+  if (sysMask & kRunning) w.S(b.running - a.running);
+  if (sysMask & kUptime) w.S(b.uptime - a.uptime);
+
+  // Removed pids, gap-encoded in ascending order.
+  vector<int> gone;
+  size_t i = 0, j = 0;
+  for (; i < prev.procs.size(); ++i) {
+    while (j < next.procs.size() && next.procs[j].pid < prev.procs[i].pid) ++j;
+    if (j == next.procs.size() || next.procs[j].pid != prev.procs[i].pid) gone.push_back(prev.procs[i].pid);
+  }
+  w.U(gone.size());
+  int lastPid = 0;
+  for (int pid : gone) {
+    w.U(pid - lastPid);
+    lastPid = pid;
+  }
+
+  // New and changed processes; a new pid is diffed against an empty record.
+  static const ProcRecord kEmpty;
+  vector<std::pair<ProcRecord const*, ProcRecord const*>> changed;
+  i = 0;
+  for (ProcRecord const& p : next.procs) {
+    while (i < prev.procs.size() && prev.procs[i].pid < p.pid) ++i;
+    bool known = i < prev.procs.size() && prev.procs[i].pid == p.pid;
+    ProcRecord const& old = known ? prev.procs[i] : kEmpty;
+    if (!known || old.ppid != p.ppid || old.jiffies != p.jiffies || old.rssKb != p.rssKb ||
+        old.start != p.start || old.user != p.user || old.command != p.command)
+      changed.emplace_back(&old, &p);
+  }
+  w.U(changed.size());
+  lastPid = 0;
+  for (auto const& [old, p] : changed) {
+    bool fresh = old == &kEmpty;
+    uint8_t mask = fresh ? kAllFields
+                         : (old->ppid != p->ppid ? kPpid : 0) | (old->jiffies != p->jiffies ? kJiffies : 0) |
+                               (old->rssKb != p->rssKb ? kRss : 0) | (old->start != p->start ? kStart : 0) |
+                               (old->user != p->user ? kUser : 0) | (old->command != p->command ? kCommand : 0);
+    w.U(p->pid - lastPid);
+    w.U(mask);
+    if (mask & kPpid) w.S(p->ppid - old->ppid);
+    if (mask & kJiffies) w.S(p->jiffies - old->jiffies);
+    if (mask & kRss) w.S(p->rssKb - old->rssKb);
+    if (mask & kStart) w.S(p->start - old->start);
+    if (mask & kUser) w.Str(p->user);
+    if (mask & kCommand) w.Str(p->command);
+    lastPid = p->pid;
+  }
+  w.Finish();
+}
+
+// Applies one frame payload to snap. A delta needs the snapshot built from
+// the preceding frames of the same stream; returns false on malformed input.
+bool Apply(uint8_t const* data, size_t size, Snapshot& snap) {
+  Reader r(data, size);
+  SystemRecord& sys = snap.system;
+  uint64_t type = r.U();
+  if (type == kFull) {
+    sys.cpu = r.U(); sys.mem = r.U(); sys.total = r.U(); sys.running = r.U();
+    sys.uptime = r.U(); sys.hz = std::max<long>(1, r.U());
+    sys.os = r.Str();
+    sys.kernel = r.Str();
+    uint64_t count = r.U();
+    if (count > r.Remaining() / kMinFullRecord) return false;
+    snap.procs.resize(count);
+    int lastPid = 0;
+    for (ProcRecord& p : snap.procs) {
+      p.pid = lastPid += r.U();
+      p.ppid = r.U(); p.jiffies = r.U(); p.rssKb = r.U(); p.start = r.U();
+      p.user = r.Str();
+      p.command = r.Str();
+    }
+    return r.Ok();
+  }
+  if (type != kDelta) return false;
+
+  uint64_t sysMask = r.U();
+  if (sysMask & kCpu) sys.cpu += r.S();
+  if (sysMask & kMem) sys.mem += r.S();
+  if (sysMask & kTotal) sys.total += r.S();
+  if (sysMask & kRunning) sys.running += r.S();
+  if (sysMask & kUptime) sys.uptime += r.S();
+
+  uint64_t removedCount = r.U();
+  if (removedCount > r.Remaining() / kMinRemoved) return false;
+  vector<int> removed(removedCount);
+  int lastPid = 0;
+  for (int& pid : removed) pid = lastPid += r.U();
+
+  // Merge the old table, the removals and the upserts, all ordered by pid.
+  vector<ProcRecord> merged;
+  merged.reserve(snap.procs.size() + 16);
+  size_t i = 0, k = 0;
+  auto keepUntil = [&](int pid) {
+    for (; i < snap.procs.size() && snap.procs[i].pid < pid; ++i) {
+      while (k < removed.size() && removed[k] < snap.procs[i].pid) ++k;
+      if (k < removed.size() && removed[k] == snap.procs[i].pid) continue;
+      merged.push_back(std::move(snap.procs[i]));
+    }
+  };
+  uint64_t changedCount = r.U();
+  if (changedCount > r.Remaining() / kMinChanged) return false;
+  lastPid = 0;
+  for (uint64_t c = 0; c < changedCount && r.Ok(); ++c) {
+    int pid = lastPid += r.U();
+    keepUntil(pid);
+    ProcRecord p;
+    if (i < snap.procs.size() && snap.procs[i].pid == pid) p = std::move(snap.procs[i++]);
+    p.pid = pid;
+    uint64_t mask = r.U();
+    if (mask & kPpid) p.ppid += r.S();
+    if (mask & kJiffies) p.jiffies += r.S();
+    if (mask & kRss) p.rssKb += r.S();
+    if (mask & kStart) p.start += r.S();
+    if (mask & kUser) p.user = r.Str();
+    if (mask & kCommand) p.command = r.Str();
+    merged.push_back(std::move(p));
+  }
+  keepUntil(std::numeric_limits<int>::max());
+  snap.procs.swap(merged);
+  return r.Ok();
+}
+
+// Lifetime CPU share and age of a remote process, from its raw counters.
+float CpuUtilization(SystemRecord const& sys, ProcRecord const& p) {
+  long seconds = sys.uptime - p.start / sys.hz;
+  return seconds > 0 ? static_cast<float>(p.jiffies) / sys.hz / seconds : 0.0f;
+}
+
+long UpTime(SystemRecord const& sys, ProcRecord const& p) { return sys.uptime - p.start / sys.hz; }
+}  // namespace Wire
+
 // -----------------------------------------------------------------------------
-// System
+// Agent
 // -----------------------------------------------------------------------------
-class System {
+// --agent [[ADDR:]PORT]: serves the local System to collectors. Each new
+// connection gets a full snapshot, then the shared per-tick delta.
+namespace Agent {
+void Capture(System& system, Wire::Snapshot& snap) {
+  Wire::SystemRecord& sys = snap.system;
+  system.Processes();
+  sys.cpu = std::lround(system.Cpu().Utilization() * 1000);
+  sys.mem = std::lround(system.MemoryUtilization() * 1000);
+  LinuxParser::ProcessTotals counts = system.ProcessCounts();
+  sys.total = counts.total;
+  sys.running = counts.running;
+  sys.uptime = system.UpTime();
+  sys.os = system.OperatingSystem();
+  sys.kernel = system.Kernel();
+
+  ProcessStore const& store = system.Store();
+  sys.hz = store.Hz();
+  snap.procs.resize(store.Size());
+  for (size_t i = 0; i < store.Size(); ++i) {
+    Wire::ProcRecord& p = snap.procs[i];
+    p.pid = store.Pid(i);
+    p.ppid = store.Ppid(i);
+    p.jiffies = store.Jiffies(i);
+    p.rssKb = store.RssKb(i);
+    p.start = store.StartTime(i);
+    p.user.assign(store.User(i).data(), store.User(i).size());
+    p.command.assign(store.Command(i).data(), store.Command(i).size());
+  }
+  auto byPid = [](Wire::ProcRecord const& a, Wire::ProcRecord const& b) { return a.pid < b.pid; };
+  if (!std::is_sorted(snap.procs.begin(), snap.procs.end(), byPid))
+    std::sort(snap.procs.begin(), snap.procs.end(), byPid);
+}
+
+bool SendAll(int fd, vector<uint8_t> const& frame) {
+  for (size_t sent = 0; sent < frame.size();) {
+    ssize_t n = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += n;
+  }
+  return true;
+}
+
+// Parses "[ADDR:]PORT" with an IPv4 ADDR; without one every interface is used.
+bool ParseListen(string const& spec, sockaddr_in& addr) {
+  addr = sockaddr_in{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  size_t colon = spec.rfind(':');
+  string port = colon == string::npos ? spec : spec.substr(colon + 1);
+  if (colon != string::npos && inet_pton(AF_INET, spec.substr(0, colon).c_str(), &addr.sin_addr) != 1)
+    return false;
+  char* end;
+  errno = 0;
+  long number = strtol(port.c_str(), &end, 10);
+  if (port.empty() || *end != '\0' || errno != 0 || number < 1 || number > 65535) return false;
+  addr.sin_port = htons(static_cast<uint16_t>(number));
+  return true;
+}
+
+// The stream is unauthenticated and includes every user name and command
+// (the first NUL-terminated field of /proc/[pid]/cmdline, usually argv[0]),
+// so bind to a private interface when the network is not trusted.
+int Run(System& system, sockaddr_in const& addr) {
+  char host[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) != 0 ||
+      bind(listener, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0 ||
+      listen(listener, 64) != 0 || fcntl(listener, F_SETFL, O_NONBLOCK) != 0) {
+    std::cerr << "agent: cannot listen on " << host << ":" << ntohs(addr.sin_port) << ": " << strerror(errno)
+              << "\n";
+    return 1;
+  }
+  std::cerr << "agent: serving " << host << ":" << ntohs(addr.sin_port) << " without authentication\n";
+
+  Wire::Snapshot prev, next;
+  vector<uint8_t> full, delta;
+  vector<int> clients, fresh;
+  while (true) {
+    for (int fd; (fd = accept(listener, nullptr, nullptr)) >= 0;) {
+      timeval timeout{1, 0};
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+      fresh.push_back(fd);
+    }
+    Capture(system, next);
+    if (!clients.empty()) Wire::EncodeDelta(prev, next, delta);
+    if (!fresh.empty()) Wire::EncodeFull(next, full);
+    // A client that cannot keep up is dropped; it will resync on reconnect.
+    auto failed = [&](int fd, vector<uint8_t> const& frame) {
+      if (SendAll(fd, frame)) return false;
+      close(fd);
+      return true;
+    };
+    clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                 [&](int fd) { return failed(fd, delta); }),
+                  clients.end());
+    for (int fd : fresh)
+      if (!failed(fd, full)) clients.push_back(fd);
+    fresh.clear();
+    std::swap(prev, next);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+}
+}  // namespace Agent
+
+// -----------------------------------------------------------------------------
+// Collector
+// -----------------------------------------------------------------------------
+// --collect host:port,...: keeps one non-blocking connection per agent,
+// reassembles frames and applies them to a per-host snapshot. Lost agents
+// are retried every few seconds and resync from a fresh full snapshot.
+class Collector {
  public:
-  Processor& Cpu() { return cpu_; }
-  vector<Process>& Processes() {
-    vector<int> pids = LinuxParser::Pids();
-    processes_.clear();
-    for (int pid : pids) {
-      Process p;
-      p.Pid(pid);
-      p.User(pid);
-      p.Command(pid);
-      p.CpuUtilization(pid);
-      p.Ram(pid);
-      p.UpTime(pid);
-      processes_.push_back(p);
-    }
-    std::sort(processes_.begin(), processes_.end(), std::greater<Process>());
-    if (processes_.size() > 50) processes_.resize(50);
-    return processes_;
+  struct Host {
+    string name, port;
+    int fd{-1};
+    bool connecting{false}, live{false};
+    sockaddr_storage address{};
+    socklen_t addressLength{0};  // 0 when the name did not resolve
+    std::chrono::steady_clock::time_point retry;
+    vector<uint8_t> inbox;
+    Wire::Snapshot snap;
+  };
+
+  explicit Collector(vector<string> const& endpoints) {
+    for (string const& endpoint : endpoints) {
+      Host host;
+      size_t colon = endpoint.rfind(':');
+      host.name = colon == string::npos ? endpoint : endpoint.substr(0, colon);
+      host.port = colon == string::npos ? to_string(kAgentPort) : endpoint.substr(colon + 1);
+      Resolve(host);
+      hosts_.push_back(std::move(host));
+    }
+  }
+  ~Collector() {
+    for (Host& host : hosts_) Drop(host);
+  }
+  Collector(Collector const&) = delete;
+  Collector& operator=(Collector const&) = delete;
+
+  vector<Host> const& Hosts() const { return hosts_; }
+
+  // Waits up to timeoutMs for traffic from any agent and applies it.
+  void Poll(int timeoutMs) {
+    auto now = std::chrono::steady_clock::now();
+    for (Host& host : hosts_)
+      if (host.fd < 0 && now >= host.retry) Connect(host);
+    fds_.clear();
+    for (Host& host : hosts_)
+      fds_.push_back({host.fd, static_cast<short>(host.connecting ? POLLOUT : POLLIN), 0});
+    if (poll(fds_.data(), fds_.size(), timeoutMs) <= 0) return;
+    for (size_t i = 0; i < hosts_.size(); ++i) {
+      Host& host = hosts_[i];
+      if (host.fd < 0 || !fds_[i].revents) continue;
+      if (host.connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(host.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error) Drop(host);
+        host.connecting = false;
+      } else {
+        Receive(host);
+      }
+    }
   }
-  string Kernel() { return LinuxParser::Kernel(); }
-  string OperatingSystem() { return LinuxParser::OperatingSystem(); }
-  float MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
-  int RunningProcesses() { return LinuxParser::RunningProcesses(); }
-  int TotalProcesses() { return LinuxParser::TotalProcesses(); }
-  long UpTime() { return LinuxParser::UpTime(); }
 
  private:
-  Processor cpu_;
-  vector<Process> processes_;
+  // Names are resolved once at startup: getaddrinfo blocks, and calling it
+  // from Poll would stall the whole view for every host that is down.
+  static void Resolve(Host& host) {
+    addrinfo hints{}, *info = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.name.c_str(), host.port.c_str(), &hints, &info) != 0) return;
+    if (info->ai_addrlen <= sizeof(host.address)) {
+      memcpy(&host.address, info->ai_addr, info->ai_addrlen);
+      host.addressLength = info->ai_addrlen;
+    }
+    freeaddrinfo(info);
+  }
+
+  void Connect(Host& host) {
+    host.retry = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    if (!host.addressLength) return;
+    host.fd = socket(host.address.ss_family, SOCK_STREAM, 0);
+    if (host.fd < 0) return;
+    fcntl(host.fd, F_SETFL, O_NONBLOCK);
+    int rc = connect(host.fd, reinterpret_cast<sockaddr const*>(&host.address), host.addressLength);
+    host.connecting = rc != 0;
+    if (rc != 0 && errno != EINPROGRESS) Drop(host);
+  }
+
+  void Drop(Host& host) {
+    if (host.fd >= 0) close(host.fd);
+    host.fd = -1;
+    host.connecting = host.live = false;
+    host.inbox.clear();
+  }
+
+  void Receive(Host& host) {
+    uint8_t buf[65536];
+    ssize_t n;
+    while ((n = recv(host.fd, buf, sizeof(buf), 0)) > 0) host.inbox.insert(host.inbox.end(), buf, buf + n);
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+      Drop(host);
+      return;
+    }
+    size_t offset = 0;
+    while (host.inbox.size() - offset >= 4) {
+      uint8_t const* p = host.inbox.data() + offset;
+      size_t size = p[0] | p[1] << 8 | p[2] << 16 | static_cast<size_t>(p[3]) << 24;
+      if (size == 0 || size > Wire::kMaxFrame) {
+        Drop(host);
+        return;
+      }
+      if (host.inbox.size() - offset - 4 < size) break;
+      // The first frame of every connection must be a full snapshot.
+      if ((!host.live && p[4] != Wire::kFull) || !Wire::Apply(p + 4, size, host.snap)) {
+        Drop(host);
+        return;
+      }
+      host.live = true;
+      offset += 4 + size;
+    }
+    host.inbox.erase(host.inbox.begin(), host.inbox.begin() + offset);
+  }
+
+  vector<Host> hosts_;
+  vector<pollfd> fds_;
 };
 
 // -----------------------------------------------------------------------------
@@ -730,55 +1642,396 @@ void DisplaySystem(System& system, WINDOW* window) {
   wattron(window, COLOR_PAIR(1));
   mvwprintw(window, row, 10, ProgressBar(system.MemoryUtilization()).c_str());
   wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(window, ++row, 2, ("Running: " + to_string(system.RunningProcesses())).c_str());
+  LinuxParser::ProcessTotals counts = system.ProcessCounts();
+  mvwprintw(window, ++row, 2, ("Total Processes: " + to_string(counts.total)).c_str());
+  mvwprintw(window, ++row, 2, ("Running: " + to_string(counts.running)).c_str());
   mvwprintw(window, ++row, 2, ("Uptime: " + ElapsedTime(system.UpTime())).c_str());
   wrefresh(window);
 }
 
-void DisplayProcesses(vector<Process>& procs, WINDOW* window) {
+void DisplayPressure(System& system, WINDOW* window) {
+  static char const* const names[] = {"cpu", "memory", "io"};
+  Pressure& pressure = system.Stalls();
+  pressure.Update();
+  int row = 0;
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "PRESSURE   SOME avg10  FULL avg10  SOME tick   FULL tick");
+  wattroff(window, COLOR_PAIR(2));
+  for (int r = 0; r < Pressure::kResources; ++r) {
+    Pressure::Stall const& stall = pressure[static_cast<Pressure::Resource>(r)];
+    mvwprintw(window, ++row, 2, "%s", names[r]);
+    if (!stall.available) {
+      mvwprintw(window, row, 13, "n/a");
+      continue;
+    }
+    mvwprintw(window, row, 13, "%6.2f%%", stall.someAvg10);
+    mvwprintw(window, row, 25, "%6.2f%%", stall.fullAvg10);
+    mvwprintw(window, row, 37, "%6.2f%%", stall.someInterval);
+    mvwprintw(window, row, 49, "%6.2f%%", stall.fullInterval);
+  }
+  wrefresh(window);
+}
+
+void DisplayProcesses(vector<Process>& procs, bool byWait, WINDOW* window) {
   int row = 0;
+  mvwprintw(window, 0, 2, " sorted by %s ", byWait ? "run-queue wait" : "CPU");
   wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, 2, "PID      USER        CPU%%   RAM(MB)  TIME     COMMAND");
+  mvwprintw(window, ++row, 2, "PID      USER        CPU%%   RAM(MB)  TIME     WAIT(ms/s) COMMAND");
   wattroff(window, COLOR_PAIR(2));
   for (size_t i = 0; i < procs.size() && i < 20; ++i) {
     mvwprintw(window, ++row, 2, "%d", procs[i].Pid());
-    mvwprintw(window, row, 11, "%s", procs[i].User().c_str());
+    std::string_view user = procs[i].User();
+    std::string_view command = procs[i].Command().substr(0, getmaxx(window) - 66);
+    mvwprintw(window, row, 11, "%.*s", static_cast<int>(user.size()), user.data());
     mvwprintw(window, row, 24, "%.1f", procs[i].CpuUtilization() * 100);
-    mvwprintw(window, row, 33, "%s", procs[i].Ram().c_str());
+    mvwprintw(window, row, 33, "%ld", procs[i].Ram());
     mvwprintw(window, row, 43, "%s", ElapsedTime(procs[i].UpTime()).c_str());
-    mvwprintw(window, row, 55, "%s", procs[i].Command().substr(0, getmaxx(window) - 55).c_str());
+    mvwprintw(window, row, 55, "%.1f", procs[i].WaitRate());
+    mvwprintw(window, row, 66, "%.*s", static_cast<int>(command.size()), command.data());
   }
   wrefresh(window);
 }
 
-void Display(System& system) {
-  initscr(); noecho(); cbreak(); start_color(); nodelay(stdscr, TRUE);
+// Row index of the selected pid in the visible tree, or 0 if it vanished.
+size_t SelectedRow(ProcessTree const& tree, int selectedPid) {
+  auto const& rows = tree.Rows();
+  for (size_t i = 0; i < rows.size(); ++i)
+    if (tree.At(rows[i].node).Pid() == selectedPid) return i;
+  return 0;
+}
+
+void DisplayTree(ProcessTree& tree, int selectedPid, WINDOW* window) {
+  int row = 0;
+  int height = getmaxy(window) - 3;
+  auto const& rows = tree.Rows();
+  size_t selected = SelectedRow(tree, selectedPid);
+  size_t first = selected >= static_cast<size_t>(height) ? selected - height + 1 : 0;
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "PID      USER        CPU%%*  RAM(MB)*  COMMAND   (* = subtree total)");
+  wattroff(window, COLOR_PAIR(2));
+  for (size_t i = first; i < rows.size() && row <= height; ++i) {
+    size_t node = rows[i].node;
+    Process p = tree.At(node);
+    std::string_view user = p.User(), command = p.Command();
+    string marker = tree.HasChildren(node) ? (tree.Collapsed(node) ? "+ " : "- ") : "  ";
+    string label = string(2 * rows[i].depth, ' ') + marker;
+    label.append(command.data(), command.size());
+    if (i == selected) wattron(window, A_REVERSE);
+    mvwprintw(window, ++row, 2, "%d", p.Pid());
+    mvwprintw(window, row, 11, "%.*s", static_cast<int>(user.size()), user.data());
+    mvwprintw(window, row, 24, "%.1f", tree.SubtreeCpu(node) * 100);
+    mvwprintw(window, row, 33, "%ld", tree.SubtreeRam(node));
+    mvwprintw(window, row, 43, "%s", label.substr(0, getmaxx(window) - 45).c_str());
+    if (i == selected) wattroff(window, A_REVERSE);
+  }
+  wrefresh(window);
+}
+
+void Display(System& system, AlertEngine& alerts) {
+  initscr(); noecho(); cbreak(); start_color(); nodelay(stdscr, TRUE); keypad(stdscr, TRUE);
   curs_set(0); init_pair(1, COLOR_BLUE, COLOR_BLACK); init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, COLOR_RED, COLOR_BLACK);
   int x_max = getmaxx(stdscr);
   WINDOW* syswin = newwin(10, x_max - 1, 0, 0);
-  WINDOW* procwin = newwin(25, x_max - 1, 11, 0);
+  WINDOW* latwin = newwin(6, x_max - 1, 11, 0);
+  WINDOW* procwin = newwin(25, x_max - 1, 18, 0);
+
+  // 't' toggles the tree view; arrows/j/k move the selection and
+  // space/enter collapses or expands the selected subtree. 's' switches the
+  // process list between CPU and run-queue wait ordering.
+  bool treeView = false, quit = false;
+  int selectedPid = 1;
+  // Keys redraw the process pane at once from the last collection; only the
+  // frame timer collects again, so the rate intervals stay a second long.
+  auto displayProcesses = [&] {
+    werase(procwin);
+    box(procwin, 0, 0);
+    if (treeView)
+      DisplayTree(system.Tree(), selectedPid, procwin);
+    else
+      DisplayProcesses(system.Listed(), system.SortedBy() == System::SortKey::kWait, procwin);
+    wrefresh(procwin);
+  };
+  // The screen is redrawn once a second; while an alert burst is active the
+  // engine samples its watched processes in between. Waiting in poll on
+  // stdin lets a keypress end the wait early.
+  auto nextFrame = AlertEngine::Clock::now(), nextSample = nextFrame;
+  while (!quit) {
+    auto now = AlertEngine::Clock::now();
+    if (now >= nextFrame) {
+      werase(syswin); werase(latwin);
+      box(syswin, 0, 0); box(latwin, 0, 0);
+      DisplaySystem(system, syswin);
+      DisplayPressure(system, latwin);
+      system.Processes();
+      alerts.Tick(system.Store());
+      if (alerts.Enabled()) {
+        int color = alerts.Bursting() ? 3 : 2;
+        wattron(syswin, COLOR_PAIR(color));
+        mvwprintw(syswin, 8, 2, "%s", ("Alerts: " + alerts.Status()).substr(0, x_max - 5).c_str());
+        wattroff(syswin, COLOR_PAIR(color));
+      }
+      wrefresh(syswin); wrefresh(latwin);
+      displayProcesses();
+      refresh();
+      nextFrame = now + std::chrono::seconds(1);
+      nextSample = now + alerts.Interval();
+    } else if (now >= nextSample) {
+      alerts.BurstSample();
+      nextSample = now + alerts.Interval();
+    }
+    auto wait = std::min(nextFrame, nextSample) - AlertEngine::Clock::now();
+    pollfd input{STDIN_FILENO, POLLIN, 0};
+    poll(&input, 1, std::max<long>(0, std::chrono::ceil<std::chrono::milliseconds>(wait).count()));
+    for (int ch; (ch = getch()) != ERR;) {
+      ProcessTree& tree = system.Tree();
+      auto const& rows = tree.Rows();
+      size_t selected = SelectedRow(tree, selectedPid);
+      if (ch == 'q' || ch == 'Q') {
+        quit = true;
+      } else if (ch == 't' || ch == 'T') {
+        treeView = !treeView;
+      } else if (ch == 's' || ch == 'S') {
+        bool byWait = system.SortedBy() == System::SortKey::kWait;
+        system.SortBy(byWait ? System::SortKey::kCpu : System::SortKey::kWait);
+      } else if (!treeView || rows.empty()) {
+        continue;
+      } else if ((ch == KEY_UP || ch == 'k') && selected > 0) {
+        selectedPid = tree.At(rows[selected - 1].node).Pid();
+      } else if ((ch == KEY_DOWN || ch == 'j') && selected + 1 < rows.size()) {
+        selectedPid = tree.At(rows[selected + 1].node).Pid();
+      } else if (ch == ' ' || ch == '\n' || ch == KEY_ENTER) {
+        selectedPid = tree.At(rows[selected].node).Pid();
+        tree.Toggle(selectedPid);
+      } else {
+        continue;
+      }
+      if (!quit) displayProcesses();
+    }
+  }
 
-  while (true) {
-    werase(syswin); werase(procwin);
-    box(syswin, 0, 0); box(procwin, 0, 0);
-    DisplaySystem(system, syswin);
-    DisplayProcesses(system.Processes(), procwin);
-    wrefresh(syswin); wrefresh(procwin); refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    int ch = getch();
-    if (ch == 'q' || ch == 'Q') break;
+  delwin(syswin); delwin(latwin); delwin(procwin); endwin();
+}
+
+void DisplayHosts(Collector const& collector, WINDOW* window) {
+  int row = 0;
+  int height = getmaxy(window) - 2;
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "HOST                CPU%%    MEM%%    PROCS   RUNNING  UPTIME    KERNEL");
+  wattroff(window, COLOR_PAIR(2));
+  for (auto const& host : collector.Hosts()) {
+    if (row >= height) break;
+    Wire::SystemRecord const& sys = host.snap.system;
+    mvwprintw(window, ++row, 2, "%s", (host.name + ":" + host.port).substr(0, 18).c_str());
+    if (!host.live) {
+      mvwprintw(window, row, 22, "%s", host.connecting ? "connecting" : host.addressLength ? "down" : "unresolved");
+      continue;
+    }
+    mvwprintw(window, row, 22, "%.1f", sys.cpu / 10.0);
+    mvwprintw(window, row, 30, "%.1f", sys.mem / 10.0);
+    mvwprintw(window, row, 38, "%ld", sys.total);
+    mvwprintw(window, row, 46, "%ld", sys.running);
+    mvwprintw(window, row, 55, "%s", ElapsedTime(sys.uptime).c_str());
+    mvwprintw(window, row, 65, "%s", sys.kernel.substr(0, std::max(0, getmaxx(window) - 67)).c_str());
   }
+  wrefresh(window);
+}
 
-  delwin(syswin); delwin(procwin); endwin();
+// Global top-N by CPU across every live host.
+void DisplayGlobalTop(Collector const& collector, WINDOW* window) {
+  struct Entry {
+    Collector::Host const* host;
+    Wire::ProcRecord const* proc;
+    float cpu;
+  };
+  vector<Entry> entries;
+  for (auto const& host : collector.Hosts())
+    if (host.live)
+      for (auto const& p : host.snap.procs)
+        entries.push_back({&host, &p, Wire::CpuUtilization(host.snap.system, p)});
+  size_t top = std::min<size_t>(entries.size(), std::max(0, getmaxy(window) - 3));
+  std::partial_sort(entries.begin(), entries.begin() + top, entries.end(),
+                    [](Entry const& a, Entry const& b) { return a.cpu > b.cpu; });
+
+  int row = 0;
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "HOST              PID      USER        CPU%%   RAM(MB)  TIME     COMMAND");
+  wattroff(window, COLOR_PAIR(2));
+  for (size_t i = 0; i < top; ++i) {
+    Wire::ProcRecord const& p = *entries[i].proc;
+    Collector::Host const& host = *entries[i].host;
+    mvwprintw(window, ++row, 2, "%s", (host.name + ":" + host.port).substr(0, 16).c_str());
+    mvwprintw(window, row, 20, "%d", p.pid);
+    mvwprintw(window, row, 29, "%s", p.user.substr(0, 11).c_str());
+    mvwprintw(window, row, 42, "%.1f", entries[i].cpu * 100);
+    mvwprintw(window, row, 51, "%ld", p.rssKb / 1024);
+    mvwprintw(window, row, 61, "%s", ElapsedTime(Wire::UpTime(host.snap.system, p)).c_str());
+    mvwprintw(window, row, 73, "%s", p.command.substr(0, std::max(0, getmaxx(window) - 75)).c_str());
+  }
+  wrefresh(window);
+}
+
+void Display(Collector& collector) {
+  initscr(); noecho(); cbreak(); start_color(); nodelay(stdscr, TRUE);
+  curs_set(0); init_pair(1, COLOR_BLUE, COLOR_BLACK); init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  int x_max = getmaxx(stdscr), y_max = getmaxy(stdscr);
+  int hostRows = std::min<int>(collector.Hosts().size() + 3, y_max / 2);
+  WINDOW* hostwin = newwin(hostRows, x_max - 1, 0, 0);
+  WINDOW* procwin = newwin(std::max(4, y_max - hostRows - 1), x_max - 1, hostRows + 1, 0);
+
+  bool quit = false;
+  while (!quit) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now())
+      collector.Poll(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+    werase(hostwin); werase(procwin);
+    box(hostwin, 0, 0); box(procwin, 0, 0);
+    DisplayHosts(collector, hostwin);
+    DisplayGlobalTop(collector, procwin);
+    wrefresh(hostwin); wrefresh(procwin); refresh();
+    for (int ch; (ch = getch()) != ERR;)
+      if (ch == 'q' || ch == 'Q') quit = true;
+  }
+
+  delwin(hostwin); delwin(procwin); endwin();
 }
 }  // namespace NCursesDisplay
 
+// -----------------------------------------------------------------------------
+// Benchmark
+// -----------------------------------------------------------------------------
+// --bench: times LinuxParser::ParseKeys against the line-by-line
+// KeyValParser it replaced, on live /proc files and on synthetic files that
+// put the wanted keys before or after a lot of filler.
+namespace Benchmark {
+// The former LinuxParser::KeyValParser, kept as the baseline.
+string KeyValParser(string key, string path) {
+  string value = "n/a", temp, line;
+  std::ifstream stream(path);
+  if (stream.is_open()) {
+    while (std::getline(stream, line)) {
+      std::istringstream linestream(line);
+      linestream >> temp;
+      if (temp == key) {
+        linestream >> value;
+        break;
+      }
+    }
+  }
+  return value;
+}
+
+template <typename F>
+double NsPerCall(int iterations, F&& call) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) call();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// The old call sites opened the file once per key, so the baseline does too.
+template <auto const& Keys, typename Record>
+void Compare(string const& label, string const& path, int iterations) {
+  Record legacy, schema;
+  auto runLegacy = [&] {
+    for (auto const& key : Keys)
+      legacy.*(key.value) = strtol(KeyValParser(string(key.name), path).c_str(), nullptr, 10);
+  };
+  auto runSchema = [&] { LinuxParser::ParseKeys<Keys>(path.c_str(), schema); };
+  double before = NsPerCall(iterations, runLegacy);
+  double after = NsPerCall(iterations, runSchema);
+  bool same = std::all_of(std::begin(Keys), std::end(Keys),
+                          [&](auto const& key) { return legacy.*(key.value) == schema.*(key.value); });
+  std::cout << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(0)
+            << std::setw(12) << before << std::setw(12) << after << std::setprecision(1) << std::setw(9)
+            << before / after << "x" << (same ? "" : "  MISMATCH") << "\n";
+}
+
+string TempFile(string const& contents) {
+  char path[] = "/tmp/monitor-bench-XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) return "";
+  close(fd);
+  std::ofstream(path) << contents;
+  return path;
+}
+
+int Run() {
+  std::ostringstream filler, intr, cpus;
+  for (int i = 0; i < 5000; ++i) filler << "Filler" << i << ":     " << i * 7 << " kB\n";
+  intr << "intr 123456789";
+  for (int i = 0; i < 5000; ++i) intr << " " << i;
+  for (int i = 0; i < 64; ++i) cpus << "cpu" << i << " 1 2 3 4 5 6 7 8 9 10\n";
+  string keysFirst = TempFile("MemTotal:       16000000 kB\nMemFree:         8000000 kB\n" + filler.str());
+  string keysLast = TempFile(cpus.str() + intr.str() + "\nctxt 42\nprocesses 4242\nprocs_running 7\n");
+  string keysSpread = TempFile("Name:\tbench\nUid:\t1000\t1000\t1000\t1000\n" + filler.str() +
+                               "VmSize:\t  123456 kB\nVmRSS:\t   65432 kB\n");
+  if (keysFirst.empty() || keysLast.empty() || keysSpread.empty()) {
+    std::cerr << "bench: cannot create temporary files\n";
+    return 1;
+  }
+
+  std::cout << std::left << std::setw(32) << "file" << std::right << std::setw(12) << "legacy ns"
+            << std::setw(12) << "schema ns" << std::setw(10) << "speedup" << "\n";
+  Compare<LinuxParser::kMemInfoKeys, LinuxParser::MemInfo>("/proc/meminfo", kProcDirectory + kMeminfoFilename, 2000);
+  Compare<LinuxParser::kProcessCountKeys, LinuxParser::ProcessTotals>("/proc/stat", kProcDirectory + kStatFilename,
+                                                                      2000);
+  Compare<LinuxParser::kProcessStatusKeys, LinuxParser::ProcessStatus>("/proc/self/status", "/proc/self/status",
+                                                                       2000);
+  Compare<LinuxParser::kMemInfoKeys, LinuxParser::MemInfo>("synthetic: keys first", keysFirst, 500);
+  Compare<LinuxParser::kProcessCountKeys, LinuxParser::ProcessTotals>("synthetic: keys after long line", keysLast,
+                                                                      500);
+  Compare<LinuxParser::kProcessStatusKeys, LinuxParser::ProcessStatus>("synthetic: keys spread", keysSpread, 500);
+  for (string const& path : {keysFirst, keysLast, keysSpread}) unlink(path.c_str());
+  return 0;
+}
+}  // namespace Benchmark
+
 // -----------------------------------------------------------------------------
 // main()
 // -----------------------------------------------------------------------------
-int main() {
+// --agent [[ADDR:]PORT] serves this host to collectors, --collect host:port,...
+// shows many agents at once and --bench runs the parser microbenchmark;
+// otherwise the local host is shown, optionally with --alert rules whose
+// bursts are appended to the --capture file.
+int main(int argc, char* argv[]) {
+  string mode = argc > 1 ? argv[1] : "";
+  if (mode == "--bench" && argc == 2) return Benchmark::Run();
+  sockaddr_in listen;
+  if (mode == "--agent" && argc <= 3 && Agent::ParseListen(argc == 3 ? argv[2] : to_string(kAgentPort), listen)) {
+    System system;
+    return Agent::Run(system, listen);
+  }
+  if (mode == "--collect" && argc == 3) {
+    vector<string> endpoints;
+    std::istringstream list(argv[2]);
+    for (string endpoint; std::getline(list, endpoint, ',');)
+      if (!endpoint.empty()) endpoints.push_back(endpoint);
+    Collector collector(endpoints);
+    NCursesDisplay::Display(collector);
+    return 0;
+  }
+  vector<AlertRule> rules;
+  string capture = "monitor-capture.tsv";
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    AlertRule rule;
+    if (arg == "--alert" && i + 1 < argc && AlertRule::Parse(argv[i + 1], rule)) {
+      rules.push_back(rule);
+      ++i;
+    } else if (arg == "--capture" && i + 1 < argc) {
+      capture = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--alert 'METRIC>THRESHOLD[:SECONDS]']... [--capture FILE]\n"
+                << "       " << argv[0] << " --agent [[ADDR:]PORT]\n"
+                << "       " << argv[0] << " --collect HOST:PORT,...\n"
+                << "       " << argv[0] << " --bench\n"
+                << "METRIC is cpu, mem, pcpu (percent) or rss_rate (MB/s per process)\n";
+      return 1;
+    }
+  }
   System system;
-  NCursesDisplay::Display(system);
+  AlertEngine alerts(rules, capture);
+  NCursesDisplay::Display(system, alerts);
   return 0;
 }